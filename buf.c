@@ -27,8 +27,6 @@
 #define SIZE_MAX ((size_t) -1)
 #endif
 
-#define WITH_BUFFER_COMPAT
-
 #define BUF_FLAG_OOM        (1u << 0)
 #define BUF_FLAG_OVERFLOW   (1u << 1)
 #define BUF_FLAG_STATIC     (1u << 2)
@@ -37,17 +35,11 @@
 #define BUF_STATIC(buf) ((buf)->flags & BUF_FLAG_STATIC)
 
 /**
- * A buffer structure. The base of the structure is somehow compatible
- * with struct _xmlBuffer to limit risks on application which accessed
- * directly the input->buf->buffer structures.
+ * A buffer structure.
  */
 
 struct _xmlBuf {
     xmlChar *content;		/* The buffer content UTF8 */
-#ifdef WITH_BUFFER_COMPAT
-    unsigned int compat_use;    /* for binary compatibility */
-    unsigned int compat_size;   /* for binary compatibility */
-#endif
     xmlChar *mem;		/* Start of the allocation */
     size_t use;		        /* The buffer size used */
     size_t size;		/* The buffer size, excluding terminating 0 */
@@ -55,35 +47,6 @@ struct _xmlBuf {
     unsigned flags;             /* flags */
 };
 
-#ifdef WITH_BUFFER_COMPAT
-/*
- * Macro for compatibility with xmlBuffer to be used after an xmlBuf
- * is updated. This makes sure the compat fields are updated too.
- */
-#define UPDATE_COMPAT(buf)				    \
-     if (buf->size < INT_MAX) buf->compat_size = buf->size; \
-     else buf->compat_size = INT_MAX;			    \
-     if (buf->use < INT_MAX) buf->compat_use = buf->use; \
-     else buf->compat_use = INT_MAX;
-
-/*
- * Macro for compatibility with xmlBuffer to be used in all the xmlBuf
- * entry points, it checks that the compat fields have not been modified
- * by direct call to xmlBuffer function from code compiled before 2.9.0 .
- */
-#define CHECK_COMPAT(buf)				    \
-     if (buf->size != (size_t) buf->compat_size)	    \
-         if (buf->compat_size < INT_MAX)		    \
-	     buf->size = buf->compat_size;		    \
-     if (buf->use != (size_t) buf->compat_use)		    \
-         if (buf->compat_use < INT_MAX)			    \
-	     buf->use = buf->compat_use;
-
-#else /* ! WITH_BUFFER_COMPAT */
-#define UPDATE_COMPAT(buf)
-#define CHECK_COMPAT(buf)
-#endif /* WITH_BUFFER_COMPAT */
-
 /**
  * Handle an out of memory condition
  * To be improved...
@@ -140,7 +103,6 @@ xmlBufCreate(size_t size) {
     ret->content = ret->mem;
     ret->content[0] = 0;
 
-    UPDATE_COMPAT(ret);
     return(ret);
 }
 
@@ -192,7 +154,6 @@ xmlBufCreateMem(const xmlChar *mem, size_t size, int isStatic) {
     ret->maxSize = SIZE_MAX - 1;
     ret->content = ret->mem;
 
-    UPDATE_COMPAT(ret);
     return(ret);
 }
 
@@ -226,7 +187,6 @@ xmlBufDetach(xmlBufPtr buf) {
     buf->size = 0;
     buf->use = 0;
 
-    UPDATE_COMPAT(buf);
     return ret;
 }
 
@@ -256,14 +216,12 @@ xmlBufEmpty(xmlBufPtr buf) {
         return;
     if (buf->mem == NULL)
         return;
-    CHECK_COMPAT(buf)
 
     buf->use = 0;
     buf->size += buf->content - buf->mem;
     buf->content = buf->mem;
     buf->content[0] = 0;
 
-    UPDATE_COMPAT(buf)
 }
 
 /**
@@ -285,7 +243,6 @@ xmlBufShrink(xmlBufPtr buf, size_t len) {
         return(0);
     if (len == 0)
         return(0);
-    CHECK_COMPAT(buf)
 
     if (len > buf->use)
         return(0);
@@ -294,7 +251,6 @@ xmlBufShrink(xmlBufPtr buf, size_t len) {
     buf->content += len;
     buf->size -= len;
 
-    UPDATE_COMPAT(buf)
     return(len);
 }
 
@@ -340,7 +296,14 @@ xmlBufGrowInternal(xmlBufPtr buf, size_t len) {
             size = buf->maxSize;
     } else {
         size = buf->use + len;
-        if (size <= buf->maxSize - 100)
+        /*
+         * Even if the request exceeds the current size, grow at least
+         * geometrically, otherwise repeated large appends degrade to
+         * quadratic behavior. Small buffers keep growing exactly.
+         */
+        if ((buf->size >= 4096) && (size <= buf->maxSize / 2))
+            size *= 2;
+        else if (size <= buf->maxSize - 100)
             size += 100;
     }
 
@@ -382,7 +345,6 @@ int
 xmlBufGrow(xmlBufPtr buf, size_t len) {
     if ((buf == NULL) || (BUF_ERROR(buf)) || (BUF_STATIC(buf)))
         return(-1);
-    CHECK_COMPAT(buf)
 
     if (len <= buf->size - buf->use)
         return(0);
@@ -390,7 +352,6 @@ xmlBufGrow(xmlBufPtr buf, size_t len) {
     if (xmlBufGrowInternal(buf, len) < 0)
         return(-1);
 
-    UPDATE_COMPAT(buf)
     return(0);
 }
 
@@ -420,7 +381,6 @@ xmlBufEnd(xmlBufPtr buf)
 {
     if ((!buf) || (BUF_ERROR(buf)))
         return NULL;
-    CHECK_COMPAT(buf)
 
     return(&buf->content[buf->use]);
 }
@@ -439,12 +399,10 @@ int
 xmlBufAddLen(xmlBufPtr buf, size_t len) {
     if ((buf == NULL) || (BUF_ERROR(buf)) || (BUF_STATIC(buf)))
         return(-1);
-    CHECK_COMPAT(buf)
     if (len > buf->size - buf->use)
         return(-1);
     buf->use += len;
     buf->content[buf->use] = 0;
-    UPDATE_COMPAT(buf)
     return(0);
 }
 
@@ -459,7 +417,6 @@ xmlBufUse(const xmlBufPtr buf)
 {
     if ((!buf) || (BUF_ERROR(buf)))
         return 0;
-    CHECK_COMPAT(buf)
 
     return(buf->use);
 }
@@ -475,7 +432,6 @@ xmlBufAvail(const xmlBufPtr buf)
 {
     if ((!buf) || (BUF_ERROR(buf)))
         return 0;
-    CHECK_COMPAT(buf)
 
     return(buf->size - buf->use);
 }
@@ -491,7 +447,6 @@ xmlBufIsEmpty(const xmlBufPtr buf)
 {
     if ((!buf) || (BUF_ERROR(buf)))
         return(-1);
-    CHECK_COMPAT(buf)
 
     return(buf->use == 0);
 }
@@ -514,7 +469,6 @@ xmlBufAdd(xmlBufPtr buf, const xmlChar *str, size_t len) {
         return(0);
     if (str == NULL)
 	return(-1);
-    CHECK_COMPAT(buf)
 
     if (len > buf->size - buf->use) {
         if (xmlBufGrowInternal(buf, len) < 0)
@@ -525,7 +479,6 @@ xmlBufAdd(xmlBufPtr buf, const xmlChar *str, size_t len) {
     buf->use += len;
     buf->content[buf->use] = 0;
 
-    UPDATE_COMPAT(buf)
     return(0);
 }
 
@@ -584,7 +537,6 @@ xmlBufFromBuffer(xmlBufferPtr buffer) {
             ret->mem = buffer->content;
     }
 
-    UPDATE_COMPAT(ret);
     return(ret);
 }
 
@@ -659,7 +611,6 @@ int
 xmlBufUpdateInput(xmlBufPtr buf, xmlParserInputPtr input, size_t pos) {
     if ((buf == NULL) || (input == NULL))
         return(-1);
-    CHECK_COMPAT(buf)
     input->base = buf->content;
     input->cur = input->base + pos;
     input->end = &buf->content[buf->use];
@@ -928,7 +879,13 @@ xmlBufferGrow(xmlBufferPtr buf, unsigned int len) {
             size = INT_MAX;
     } else {
         size = buf->use + len + 1;
-        if (size <= INT_MAX - 100)
+        /*
+         * Grow at least geometrically for large appends as well, see
+         * xmlBufGrowInternal.
+         */
+        if ((buf->size >= 4096) && (size <= INT_MAX / 2))
+            size *= 2;
+        else if (size <= INT_MAX - 100)
             size += 100;
     }
 
@@ -1177,24 +1134,27 @@ xmlBufferWriteQuotedString(xmlBufferPtr buf, const xmlChar *string) {
     const xmlChar *cur, *base;
     if (buf == NULL)
         return;
-    if (xmlStrchr(string, '\"')) {
-        if (xmlStrchr(string, '\'')) {
+    if (string == NULL) {
+        xmlBufferCCat(buf, "\"\"");
+        return;
+    }
+    /*
+     * strchr is typically vectorized, making both the quote probes
+     * and the escape loop below jump from quote to quote instead of
+     * stepping bytes.
+     */
+    if (strchr((const char *) string, '"')) {
+        if (strchr((const char *) string, '\'')) {
 	    xmlBufferCCat(buf, "\"");
-            base = cur = string;
-            while(*cur != 0){
-                if(*cur == '"'){
-                    if (base != cur)
-                        xmlBufferAdd(buf, base, cur - base);
-                    xmlBufferAdd(buf, BAD_CAST "&quot;", 6);
-                    cur++;
-                    base = cur;
-                }
-                else {
-                    cur++;
-                }
+            base = string;
+            while ((cur = (const xmlChar *) strchr((const char *) base,
+                                                   '"')) != NULL) {
+                if (cur != base)
+                    xmlBufferAdd(buf, base, cur - base);
+                xmlBufferAdd(buf, BAD_CAST "&quot;", 6);
+                base = cur + 1;
             }
-            if (base != cur)
-                xmlBufferAdd(buf, base, cur - base);
+            xmlBufferCat(buf, base);
 	    xmlBufferCCat(buf, "\"");
 	}
         else{
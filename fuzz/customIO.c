@@ -0,0 +1,53 @@
+/*
+ * customIO.c: Custom input callbacks shared between fuzz targets.
+ *
+ * See Copyright for the status of this software.
+ */
+
+#include <libxml/xmlIO.h>
+
+#include "fuzz.h"
+
+/*
+ * Stub input callbacks simulating a broken custom handler. Matching
+ * every URI routes all input-buffer creation through the custom I/O
+ * code paths.
+ */
+
+int
+fuzzCustomIOMatch(const char *URI ATTRIBUTE_UNUSED) {
+    return 1;
+}
+
+void *
+fuzzCustomIOOpen(const char *URI ATTRIBUTE_UNUSED) {
+    return NULL;
+}
+
+int
+fuzzCustomIORead(void *ctx ATTRIBUTE_UNUSED, char *buf ATTRIBUTE_UNUSED,
+                 int len ATTRIBUTE_UNUSED) {
+    return -1;
+}
+
+int
+fuzzCustomIOClose(void *ctx ATTRIBUTE_UNUSED) {
+    return 0;
+}
+
+/*
+ * fuzzCustomIORegister:
+ *
+ * Register the custom input callbacks. Safe to call more than once;
+ * registration is only performed on the first call.
+ */
+void
+fuzzCustomIORegister(void) {
+    static int registered = 0;
+
+    if (!registered) {
+        xmlRegisterInputCallbacks(fuzzCustomIOMatch, fuzzCustomIOOpen,
+                                  fuzzCustomIORead, fuzzCustomIOClose);
+        registered = 1;
+    }
+}
@@ -261,6 +261,24 @@ xmlFuzzReadInt(int size) {
     return ret;
 }
 
+/**
+ * xmlFuzzReadBytes:
+ * @buf:  destination buffer
+ * @size:  number of bytes to read
+ *
+ * Copy bytes from the fuzz data in a single operation. If not enough
+ * data remains, the tail of the buffer is zero-filled.
+ */
+void
+xmlFuzzReadBytes(void *buf, size_t size) {
+    size_t avail = size < fuzzData.remaining ? size : fuzzData.remaining;
+
+    memcpy(buf, fuzzData.ptr, avail);
+    memset((char *) buf + avail, 0, size - avail);
+    fuzzData.ptr += avail;
+    fuzzData.remaining -= avail;
+}
+
 /**
  * xmlFuzzBytesRemaining:
  *
@@ -21,6 +21,11 @@ extern "C" {
   #define ATTRIBUTE_UNUSED
 #endif
 
+/* Some fuzz targets use private library APIs. */
+#ifndef XML_HIDDEN
+  #define XML_HIDDEN
+#endif
+
 #if defined(LIBXML_HTML_ENABLED)
   #define HAVE_HTML_FUZZER
 #endif
@@ -108,6 +113,9 @@ xmlFuzzWriteInt(FILE *out, size_t v, int size);
 size_t
 xmlFuzzReadInt(int size);
 
+void
+xmlFuzzReadBytes(void *buf, size_t size);
+
 size_t
 xmlFuzzBytesRemaining(void);
 
@@ -140,6 +148,21 @@ xmlFuzzResourceLoader(void *data, const char *URL, const char *ID,
                       xmlResourceType type, xmlParserInputFlags flags,
                       xmlParserInputPtr *out);
 
+int
+fuzzCustomIOMatch(const char *URI);
+
+void *
+fuzzCustomIOOpen(const char *URI);
+
+int
+fuzzCustomIORead(void *ctx, char *buf, int len);
+
+int
+fuzzCustomIOClose(void *ctx);
+
+void
+fuzzCustomIORegister(void);
+
 char *
 xmlSlurpFile(const char *path, size_t *size);
 
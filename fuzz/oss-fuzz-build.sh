@@ -40,11 +40,14 @@ make clean-corpus
 make fuzz.o
 
 for fuzzer in \
-    api html lint reader regexp schema uri valid xinclude xml xpath 
+    api html lint reader regexp schema uri valid xinclude xml xmlIO-uri xpath
 do
     OBJS="$fuzzer.o"
     if [ "$fuzzer" = lint ]; then
-        OBJS="$OBJS ../xmllint.o ../shell.o"
+        OBJS="$OBJS customIO.o ../xmllint.o ../shell.o"
+    fi
+    if [ "$fuzzer" = xmlIO-uri ]; then
+        OBJS="$OBJS customIO.o"
     fi
     make $OBJS
     # Link with $CXX
@@ -0,0 +1,46 @@
+#!/bin/sh
+
+set -e
+
+fuzzer="$1"
+runs="${2:-1000000}"
+
+if [ -z "$fuzzer" ]; then
+    echo usage: $0 fuzzer [runs]
+    exit 1
+fi
+
+# Rebuild the project with profile generation enabled
+
+make distclean
+export CC=clang
+export CXX=clang++
+common_cflags=" \
+    -O2 \
+    -fsanitize=fuzzer-no-link \
+    -DFUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION"
+export CFLAGS="$common_cflags -fprofile-generate"
+sh autogen.sh --without-python
+make -j5
+
+# Collect a profile from a fuzzing session on the corpus
+
+cd fuzz
+make $fuzzer
+
+mkdir -p corpus/$fuzzer
+LLVM_PROFILE_FILE=$fuzzer.%p.profraw ./$fuzzer -runs=$runs corpus/$fuzzer
+
+llvm-profdata merge -output=$fuzzer.profdata $fuzzer.*.profraw
+rm -f $fuzzer.*.profraw
+profdata="$PWD/$fuzzer.profdata"
+
+# Rebuild with the profile and LTO
+
+cd ..
+export CFLAGS="$common_cflags -fprofile-use=$profdata -flto"
+make clean
+make -j5
+
+cd fuzz
+make $fuzzer
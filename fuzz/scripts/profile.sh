@@ -0,0 +1,26 @@
+#!/bin/sh
+
+set -e
+
+fuzzer="$1"
+runs="${2:-10000}"
+
+if [ -z "$fuzzer" ]; then
+    echo usage: $0 fuzzer [runs]
+    exit 1
+fi
+
+cd fuzz
+make $fuzzer
+
+# Replay the corpus for a fixed number of runs and report wall, user
+# and system time along with page faults and peak RSS. If perf is
+# available, also collect basic CPU counters to tell compute-bound from
+# memory-bound behavior.
+
+if command -v perf > /dev/null 2>&1; then
+    exec perf stat -d /usr/bin/time -v \
+        ./$fuzzer -runs=$runs corpus/$fuzzer
+else
+    exec /usr/bin/time -v ./$fuzzer -runs=$runs corpus/$fuzzer
+fi
@@ -0,0 +1,76 @@
+/*
+ * xmlIO-uri.c: a libFuzzer target to test xmlParserInputBufferCreateUrl
+ * with custom input callbacks.
+ *
+ * See Copyright for the status of this software.
+ */
+
+#include <libxml/parser.h>
+#include <libxml/xmlIO.h>
+
+#include "fuzz.h"
+
+#include "private/io.h"
+
+int
+LLVMFuzzerInitialize(int *argc ATTRIBUTE_UNUSED,
+                     char ***argv ATTRIBUTE_UNUSED) {
+    xmlFuzzMemSetup();
+    fuzzCustomIORegister();
+
+    return 0;
+}
+
+int
+LLVMFuzzerTestOneInput(const char *data, size_t size) {
+    xmlParserInputBufferPtr buf = NULL;
+    const char *url;
+    size_t failurePos, urlSize;
+
+    /*
+     * The input is used as URL and must be a null-terminated string.
+     * Most mutated inputs aren't, so let the reject path retire with a
+     * single predicted load and compare.
+     */
+    if (__builtin_expect((size == 0) || (data[size - 1] != '\0'), 1))
+        return 0;
+
+    xmlFuzzDataInit(data, size);
+    failurePos = xmlFuzzReadInt(4) % (size * 8 + 100);
+    url = xmlFuzzReadRemaining(&urlSize);
+
+    if (urlSize > 0) {
+        xmlFuzzInjectFailure(failurePos);
+        xmlParserInputBufferCreateUrl(url, XML_CHAR_ENCODING_NONE, 0, &buf);
+        if (buf != NULL)
+            xmlFreeParserInputBuffer(buf);
+        xmlFuzzInjectFailure(0);
+    }
+
+    xmlFuzzDataCleanup();
+
+    return 0;
+}
+
+/*
+ * Keep mutated inputs null-terminated. Without this, almost all
+ * generic mutations fail the termination check and are rejected
+ * before reaching any interesting code.
+ */
+size_t
+LLVMFuzzerCustomMutator(char *data, size_t size, size_t maxSize,
+                        unsigned seed) {
+    static const xmlFuzzChunkDesc chunks[] = {
+        { 4, XML_FUZZ_PROB_ONE / 10 }, /* failurePos */
+        { 0, 0 }
+    };
+    size_t newSize;
+
+    newSize = xmlFuzzMutateChunks(chunks, data, size, maxSize, seed,
+                                  LLVMFuzzerMutate);
+    if (newSize == 0)
+        newSize = 1;
+    data[newSize - 1] = '\0';
+
+    return newSize;
+}
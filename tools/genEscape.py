@@ -39,9 +39,13 @@ print('static const char xmlEscapeContent[] = {%s\n};\n' % r)
 def gen_tab(name, escape, is_xml):
     r = ''
 
-    for i in range(0x80):
+    for i in range(0x100):
 
-        if chr(i) in escape:
+        if i >= 0x80:
+            # Never matched by the table scan itself; allows indexing
+            # with a full byte without a range check.
+            v = -1
+        elif chr(i) in escape:
             v = offset[i]
         elif i == 0:
             v = 0
@@ -54,7 +58,7 @@ def gen_tab(name, escape, is_xml):
         else: r += ' '
         r += '%2d,' % v
 
-    print('static const signed char %s[128] = {%s\n};\n' % (name, r))
+    print('static const signed char %s[256] = {%s\n};\n' % (name, r))
 
 gen_tab('xmlEscapeTab', '\r&<>', True)
 gen_tab('xmlEscapeTabQuot', '\r"&<>', True)
@@ -211,7 +211,8 @@ xmlBuildQName(const xmlChar *ncname, const xmlChar *prefix,
  */
 xmlChar *
 xmlSplitQName2(const xmlChar *name, xmlChar **prefix) {
-    int len = 0;
+    const xmlChar *colon;
+    int len;
     xmlChar *ret = NULL;
 
     if (prefix == NULL) return(NULL);
@@ -223,14 +224,16 @@ xmlSplitQName2(const xmlChar *name, xmlChar **prefix) {
 	return(NULL);
 
     /*
-     * we are not trying to validate but just to cut, and yes it will
-     * work even if this is as set of UTF-8 encoded chars
+     * We are not trying to validate but just to cut, and yes it will
+     * work even if this is a set of UTF-8 encoded chars. strchr
+     * typically uses vectorized scanning, beating a byte loop on
+     * longer names.
      */
-    while ((name[len] != 0) && (name[len] != ':'))
-	len++;
+    colon = (const xmlChar *) strchr((const char *) name, ':');
 
-    if ((name[len] == 0) || (name[len+1] == 0))
+    if ((colon == NULL) || (colon[1] == 0))
 	return(NULL);
+    len = colon - name;
 
     *prefix = xmlStrndup(name, len);
     if (*prefix == NULL)
@@ -259,7 +262,7 @@ xmlSplitQName2(const xmlChar *name, xmlChar **prefix) {
 
 const xmlChar *
 xmlSplitQName3(const xmlChar *name, int *len) {
-    int l = 0;
+    const xmlChar *colon;
 
     if (name == NULL) return(NULL);
     if (len == NULL) return(NULL);
@@ -269,18 +272,17 @@ xmlSplitQName3(const xmlChar *name, int *len) {
 	return(NULL);
 
     /*
-     * we are not trying to validate but just to cut, and yes it will
-     * work even if this is as set of UTF-8 encoded chars
+     * We are not trying to validate but just to cut, and yes it will
+     * work even if this is a set of UTF-8 encoded chars.
      */
-    while ((name[l] != 0) && (name[l] != ':'))
-	l++;
+    colon = (const xmlChar *) strchr((const char *) name, ':');
 
-    if ((name[l] == 0) || (name[l+1] == 0))
+    if ((colon == NULL) || (colon[1] == 0))
 	return(NULL);
 
-    *len = l;
+    *len = colon - name;
 
-    return(&name[l+1]);
+    return(colon + 1);
 }
 
 /**
@@ -297,8 +299,8 @@ xmlSplitQName3(const xmlChar *name, int *len) {
  */
 const xmlChar *
 xmlSplitQName4(const xmlChar *name, xmlChar **prefixPtr) {
+    const xmlChar *colon;
     xmlChar *prefix;
-    int l = 0;
 
     if ((name == NULL) || (prefixPtr == NULL))
         return(NULL);
@@ -310,24 +312,23 @@ xmlSplitQName4(const xmlChar *name, xmlChar **prefixPtr) {
 	return(name);
 
     /*
-     * we are not trying to validate but just to cut, and yes it will
-     * work even if this is as set of UTF-8 encoded chars
+     * We are not trying to validate but just to cut, and yes it will
+     * work even if this is a set of UTF-8 encoded chars.
      */
-    while ((name[l] != 0) && (name[l] != ':'))
-	l++;
+    colon = (const xmlChar *) strchr((const char *) name, ':');
 
     /*
      * TODO: What about names with multiple colons?
      */
-    if ((name[l] == 0) || (name[l+1] == 0))
+    if ((colon == NULL) || (colon[1] == 0))
 	return(name);
 
-    prefix = xmlStrndup(name, l);
+    prefix = xmlStrndup(name, colon - name);
     if (prefix == NULL)
         return(NULL);
 
     *prefixPtr = prefix;
-    return(&name[l+1]);
+    return(colon + 1);
 }
 
 /************************************************************************
@@ -338,6 +339,34 @@ xmlSplitQName4(const xmlChar *name, xmlChar **prefixPtr) {
 
 #define CUR_SCHAR(s, l) xmlStringCurrentChar(NULL, s, &l)
 
+/*
+ * Byte classes for the ASCII fast paths below, in the style of
+ * xmlIsPubidChar_tab. Bytes outside the ASCII range have no bits set,
+ * diverting to the full UTF-8 check.
+ */
+#define NAME_ASCII_START 1  /* [A-Za-z_] */
+#define NAME_ASCII_CHAR  2  /* [A-Za-z0-9_.-] */
+#define NAME_ASCII_COLON 4  /* ':' */
+
+static const unsigned char xmlNameAsciiTab[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 0,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 4, 0, 0, 0, 0, 0,
+    0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 0, 0, 3,
+    0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
 /**
  * Check that a value conforms to the lexical space of NCName
  *
@@ -359,15 +388,11 @@ xmlValidateNCName(const xmlChar *value, int space) {
      */
     if (space)
 	while (IS_BLANK_CH(*cur)) cur++;
-    if (((*cur >= 'a') && (*cur <= 'z')) || ((*cur >= 'A') && (*cur <= 'Z')) ||
-	(*cur == '_'))
+    if (xmlNameAsciiTab[*cur] & NAME_ASCII_START)
 	cur++;
     else
 	goto try_complex;
-    while (((*cur >= 'a') && (*cur <= 'z')) ||
-	   ((*cur >= 'A') && (*cur <= 'Z')) ||
-	   ((*cur >= '0') && (*cur <= '9')) ||
-	   (*cur == '_') || (*cur == '-') || (*cur == '.'))
+    while (xmlNameAsciiTab[*cur] & NAME_ASCII_CHAR)
 	cur++;
     if (space)
 	while (IS_BLANK_CH(*cur)) cur++;
@@ -428,28 +453,19 @@ xmlValidateQName(const xmlChar *value, int space) {
      */
     if (space)
 	while (IS_BLANK_CH(*cur)) cur++;
-    if (((*cur >= 'a') && (*cur <= 'z')) || ((*cur >= 'A') && (*cur <= 'Z')) ||
-	(*cur == '_'))
+    if (xmlNameAsciiTab[*cur] & NAME_ASCII_START)
 	cur++;
     else
 	goto try_complex;
-    while (((*cur >= 'a') && (*cur <= 'z')) ||
-	   ((*cur >= 'A') && (*cur <= 'Z')) ||
-	   ((*cur >= '0') && (*cur <= '9')) ||
-	   (*cur == '_') || (*cur == '-') || (*cur == '.'))
+    while (xmlNameAsciiTab[*cur] & NAME_ASCII_CHAR)
 	cur++;
     if (*cur == ':') {
 	cur++;
-	if (((*cur >= 'a') && (*cur <= 'z')) ||
-	    ((*cur >= 'A') && (*cur <= 'Z')) ||
-	    (*cur == '_'))
+	if (xmlNameAsciiTab[*cur] & NAME_ASCII_START)
 	    cur++;
 	else
 	    goto try_complex;
-	while (((*cur >= 'a') && (*cur <= 'z')) ||
-	       ((*cur >= 'A') && (*cur <= 'Z')) ||
-	       ((*cur >= '0') && (*cur <= '9')) ||
-	       (*cur == '_') || (*cur == '-') || (*cur == '.'))
+	while (xmlNameAsciiTab[*cur] & NAME_ASCII_CHAR)
 	    cur++;
     }
     if (space)
@@ -524,15 +540,11 @@ xmlValidateName(const xmlChar *value, int space) {
      */
     if (space)
 	while (IS_BLANK_CH(*cur)) cur++;
-    if (((*cur >= 'a') && (*cur <= 'z')) || ((*cur >= 'A') && (*cur <= 'Z')) ||
-	(*cur == '_') || (*cur == ':'))
+    if (xmlNameAsciiTab[*cur] & (NAME_ASCII_START | NAME_ASCII_COLON))
 	cur++;
     else
 	goto try_complex;
-    while (((*cur >= 'a') && (*cur <= 'z')) ||
-	   ((*cur >= 'A') && (*cur <= 'Z')) ||
-	   ((*cur >= '0') && (*cur <= '9')) ||
-	   (*cur == '_') || (*cur == '-') || (*cur == '.') || (*cur == ':'))
+    while (xmlNameAsciiTab[*cur] & (NAME_ASCII_CHAR | NAME_ASCII_COLON))
 	cur++;
     if (space)
 	while (IS_BLANK_CH(*cur)) cur++;
@@ -591,17 +603,11 @@ xmlValidateNMToken(const xmlChar *value, int space) {
      */
     if (space)
 	while (IS_BLANK_CH(*cur)) cur++;
-    if (((*cur >= 'a') && (*cur <= 'z')) ||
-        ((*cur >= 'A') && (*cur <= 'Z')) ||
-        ((*cur >= '0') && (*cur <= '9')) ||
-        (*cur == '_') || (*cur == '-') || (*cur == '.') || (*cur == ':'))
+    if (xmlNameAsciiTab[*cur] & (NAME_ASCII_CHAR | NAME_ASCII_COLON))
 	cur++;
     else
 	goto try_complex;
-    while (((*cur >= 'a') && (*cur <= 'z')) ||
-	   ((*cur >= 'A') && (*cur <= 'Z')) ||
-	   ((*cur >= '0') && (*cur <= '9')) ||
-	   (*cur == '_') || (*cur == '-') || (*cur == '.') || (*cur == ':'))
+    while (xmlNameAsciiTab[*cur] & (NAME_ASCII_CHAR | NAME_ASCII_COLON))
 	cur++;
     if (space)
 	while (IS_BLANK_CH(*cur)) cur++;
@@ -1145,6 +1151,20 @@ xmlNodeParseContentInternal(const xmlDoc *doc, xmlNodePtr parent,
     if ((value == NULL) || (value[0] == 0))
         goto done;
 
+    /*
+     * Most content contains no references. If there's no ampersand,
+     * the result is a single text node; skip the buffer machinery.
+     */
+    if ((len < 0) &&
+        (strchr((const char *) value, '&') == NULL)) {
+        head = xmlNewDocText(doc, value);
+        if (head == NULL)
+            return(-1);
+        head->parent = parent;
+        last = head;
+        goto done;
+    }
+
     cur = value;
 
     buf = xmlBufCreate(50);
@@ -1447,8 +1467,10 @@ xmlStringGetNodeList(const xmlDoc *doc, const xmlChar *value) {
  */
 xmlChar *
 xmlNodeListGetStringInternal(const xmlNode *node, int escape, int flags) {
+    const xmlNode *cur;
     xmlBufPtr buf;
     xmlChar *ret;
+    size_t size;
 
     if (node == NULL)
         return(xmlStrdup(BAD_CAST ""));
@@ -1462,7 +1484,23 @@ xmlNodeListGetStringInternal(const xmlNode *node, int escape, int flags) {
         return(xmlStrdup(node->content));
     }
 
-    buf = xmlBufCreate(50);
+    /*
+     * Pre-pass summing the text sizes so that the buffer can be
+     * allocated upfront in the common case. Escaping and entity
+     * expansion can exceed the estimate; the buffer then simply
+     * grows.
+     */
+    size = 0;
+    for (cur = node; cur != NULL; cur = cur->next) {
+        if (((cur->type == XML_TEXT_NODE) ||
+             (cur->type == XML_CDATA_SECTION_NODE)) &&
+            (cur->content != NULL))
+            size += strlen((const char *) cur->content);
+        else if (cur->type == XML_ENTITY_REF_NODE)
+            size += strlen((const char *) cur->name) + 2;
+    }
+
+    buf = xmlBufCreate(size + 1 > 50 ? size + 1 : 50);
     if (buf == NULL)
         return(NULL);
 
@@ -2371,11 +2409,17 @@ xmlNewReference(const xmlDoc *doc, const xmlChar *name) {
         name++;
 	len = xmlStrlen(name);
 	if (name[len - 1] == ';')
-	    cur->name = xmlStrndup(name, len - 1);
-	else
-	    cur->name = xmlStrndup(name, len);
-    } else
-	cur->name = xmlStrdup(name);
+	    len--;
+        if ((doc != NULL) && (doc->dict != NULL))
+            cur->name = (xmlChar *) xmlDictLookup(doc->dict, name, len);
+        else
+            cur->name = xmlStrndup(name, len);
+    } else {
+        if ((doc != NULL) && (doc->dict != NULL))
+            cur->name = (xmlChar *) xmlDictLookup(doc->dict, name, -1);
+        else
+            cur->name = xmlStrdup(name);
+    }
     if (cur->name == NULL)
         goto error;
 
@@ -5330,10 +5374,44 @@ xmlBufGetEntityRefContent(xmlBufPtr buf, const xmlNode *ref) {
     ent->flags &= ~XML_ENT_EXPANDING;
 }
 
+/*
+ * Lower bound of the subtree's text size, used to grow the target
+ * buffer upfront. Entity references aren't expanded; the buffer
+ * simply grows if their content exceeds the estimate.
+ */
+static size_t
+xmlNodeChildContentSize(const xmlNode *tree) {
+    const xmlNode *cur = tree->children;
+    size_t size = 0;
+
+    while (cur != NULL) {
+        if (((cur->type == XML_TEXT_NODE) ||
+             (cur->type == XML_CDATA_SECTION_NODE)) &&
+            (cur->content != NULL)) {
+            size += strlen((const char *) cur->content);
+        } else if ((cur->type != XML_ENTITY_REF_NODE) &&
+                   (cur->children != NULL)) {
+            cur = cur->children;
+            continue;
+        }
+
+        while (cur->next == NULL) {
+            cur = cur->parent;
+            if (cur == tree)
+                return(size);
+        }
+        cur = cur->next;
+    }
+
+    return(size);
+}
+
 static void
 xmlBufGetChildContent(xmlBufPtr buf, const xmlNode *tree) {
     const xmlNode *cur = tree->children;
 
+    xmlBufGrow(buf, xmlNodeChildContentSize(tree));
+
     while (cur != NULL) {
         switch (cur->type) {
             case XML_TEXT_NODE:
@@ -6801,12 +6879,12 @@ xmlIsBlankNode(const xmlNode *node) {
 	return(0);
     if (node->content == NULL) return(1);
     cur = node->content;
-    while (*cur != 0) {
-	if (!IS_BLANK_CH(*cur)) return(0);
-	cur++;
-    }
 
-    return(1);
+    /*
+     * The node is blank if the whitespace prefix covers the whole
+     * content. strspn beats a byte loop on longer runs.
+     */
+    return(cur[strspn((const char *) cur, " \t\n\r")] == 0);
 }
 
 /**
@@ -2226,6 +2226,67 @@ xmlNodeDump(xmlBufferPtr buf, xmlDocPtr doc, xmlNodePtr cur, int level,
  *     is returned or `buf` stores the error
  */
 
+/*
+ * Rough lower bound of the serialized size of a subtree, used to
+ * grow the output buffer upfront. Escaping and indentation can
+ * exceed the estimate; the buffer then grows normally.
+ */
+static size_t
+xmlNodeDumpEstimate(const xmlNode *root) {
+    const xmlNode *cur = root;
+    size_t size = 0;
+
+    while (1) {
+        switch (cur->type) {
+            case XML_ELEMENT_NODE: {
+                const xmlAttr *attr;
+
+                /* opening and closing tag plus delimiters */
+                size += 2 * strlen((const char *) cur->name) + 5;
+                for (attr = cur->properties; attr != NULL;
+                     attr = attr->next) {
+                    size += strlen((const char *) attr->name) + 4;
+                    if ((attr->children != NULL) &&
+                        (attr->children->type == XML_TEXT_NODE) &&
+                        (attr->children->content != NULL))
+                        size += strlen((const char *)
+                                       attr->children->content);
+                }
+                break;
+            }
+
+            case XML_TEXT_NODE:
+            case XML_CDATA_SECTION_NODE:
+            case XML_COMMENT_NODE:
+            case XML_PI_NODE:
+                if (cur->content != NULL)
+                    size += strlen((const char *) cur->content) + 7;
+                break;
+
+            case XML_ENTITY_REF_NODE:
+                size += strlen((const char *) cur->name) + 2;
+                break;
+
+            default:
+                break;
+        }
+
+        if ((cur->type == XML_ELEMENT_NODE) && (cur->children != NULL)) {
+            cur = cur->children;
+            continue;
+        }
+
+        while (cur->next == NULL) {
+            if ((cur == root) || (cur->parent == NULL))
+                return(size);
+            cur = cur->parent;
+        }
+        if (cur == root)
+            return(size);
+        cur = cur->next;
+    }
+}
+
 size_t
 xmlBufNodeDump(xmlBufPtr buf, xmlDocPtr doc, xmlNodePtr cur, int level,
             int format)
@@ -2242,6 +2303,8 @@ xmlBufNodeDump(xmlBufPtr buf, xmlDocPtr doc, xmlNodePtr cur, int level,
     if (buf == NULL) {
         return ((size_t) -1);
     }
+
+    xmlBufGrow(buf, xmlNodeDumpEstimate(cur));
     outbuf = (xmlOutputBufferPtr) xmlMalloc(sizeof(xmlOutputBuffer));
     if (outbuf == NULL) {
         xmlSaveErrMemory(NULL);